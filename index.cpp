@@ -4,342 +4,1333 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
 using namespace std;
 
+// Bytes a heap block of `size` bytes occupies under glibc malloc on 64-bit targets: an
+// 8-byte size header, rounded up to 16 bytes, at least 32. The memory report charges
+// every allocation through this so its totals match what the process holds.
+inline size_t allocationBytes(size_t size)
+{
+    size_t chunk = (size + 8 + 15) & ~(size_t)15;
+    return size == 0 ? 0 : chunk < 32 ? 32 : chunk;
+}
+
+// Vector of trivially copyable ids that keeps up to N items inline and only allocates
+// once it outgrows them. Most users have a handful of edges, so most lists never allocate.
+template <class T, uint32_t N>
+class SmallVector
+{
+    static_assert(is_trivially_copyable<T>::value, "SmallVector copies items with memcpy");
+
+private:
+    uint32_t count;
+    uint32_t capacity; // equals N while the items are stored inline
+    union
+    {
+        T local[N];
+        T *heap;
+    };
+
+    bool isInline() const { return capacity == N; }
+
+public:
+    SmallVector() : count(0), capacity(N) {}
+    SmallVector(const SmallVector &other) : count(0), capacity(N) { *this = other; }
+    ~SmallVector()
+    {
+        if (!isInline())
+            delete[] heap;
+    }
+
+    SmallVector &operator=(const SmallVector &other)
+    {
+        if (this != &other)
+        {
+            count = 0;
+            reserve(other.count);
+            memcpy(data(), other.data(), other.count * sizeof(T));
+            count = other.count;
+        }
+        return *this;
+    }
+
+    T *data() { return isInline() ? local : heap; }
+    const T *data() const { return isInline() ? local : heap; }
+    T *begin() { return data(); }
+    T *end() { return data() + count; }
+    const T *begin() const { return data(); }
+    const T *end() const { return data() + count; }
+    uint32_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    void reserve(uint32_t n)
+    {
+        if (n <= capacity)
+            return;
+        T *grown = new T[n];
+        memcpy(grown, data(), count * sizeof(T));
+        if (!isInline())
+            delete[] heap;
+        heap = grown;
+        capacity = n;
+    }
+
+    void push_back(const T &item)
+    {
+        if (count == capacity)
+            reserve(capacity * 2);
+        data()[count++] = item;
+    }
+
+    void remove(const T &item) { count = std::remove(begin(), end(), item) - begin(); }
+
+    // Bytes holding items: the inline slots in use, or the whole heap block
+    size_t itemBytes() const { return isInline() ? count * sizeof(T) : allocationBytes(capacity * sizeof(T)); }
+
+    // Fixed cost of the list itself, excluding what itemBytes() counts
+    size_t headerBytes() const { return sizeof(SmallVector) - (isInline() ? count * sizeof(T) : 0); }
+};
+
+typedef SmallVector<uint32_t, 4> IdList;
+
+// Append-only array addressed by 32-bit index, stored in segments that double in size
+// (the first holds 2^FirstBits items). Items never move once written, so a reader that
+// learned an index from a published snapshot can use it while writers keep appending,
+// and a small instance only pays for its first segment.
+template <class T, uint32_t FirstBits = 4>
+class SegmentedArray
+{
+private:
+    static const uint32_t maxSegments = 32 - FirstBits;
+
+    T *segments[maxSegments];
+    uint32_t count;
+
+    static uint32_t floorLog2(uint32_t v)
+    {
+        uint32_t log = 0;
+        for (uint32_t shift = 16; shift > 0; shift /= 2)
+        {
+            if (v >> shift)
+            {
+                v >>= shift;
+                log += shift;
+            }
+        }
+        return log;
+    }
+
+    static uint32_t segmentOf(uint32_t index) { return floorLog2((index >> FirstBits) + 1); }
+    static uint32_t segmentStart(uint32_t segment) { return ((1u << segment) - 1) << FirstBits; }
+    static uint32_t segmentSize(uint32_t segment) { return 1u << (segment + FirstBits); }
+
+public:
+    SegmentedArray() : count(0)
+    {
+        for (T *&segment : segments)
+            segment = nullptr;
+    }
+    SegmentedArray(const SegmentedArray &) = delete;
+    SegmentedArray &operator=(const SegmentedArray &) = delete;
+
+    ~SegmentedArray()
+    {
+        for (T *segment : segments)
+            delete[] segment;
+    }
+
+    // Appends n items that stay contiguous, skipping to the next segment if they do not
+    // fit in the current one; returns the index of the first
+    uint32_t append(const T *items, uint32_t n)
+    {
+        uint32_t segment = segmentOf(count);
+        if (count + n > segmentStart(segment) + segmentSize(segment))
+        {
+            while (segmentSize(++segment) < n)
+                ;
+            count = segmentStart(segment);
+        }
+        if (!segments[segment])
+            segments[segment] = new T[segmentSize(segment)];
+        uint32_t first = count;
+        copy(items, items + n, segments[segment] + (first - segmentStart(segment)));
+        count += n;
+        return first;
+    }
+
+    uint32_t push_back(const T &item) { return append(&item, 1); }
+
+    const T &operator[](uint32_t index) const
+    {
+        uint32_t segment = segmentOf(index);
+        return segments[segment][index - segmentStart(segment)];
+    }
+
+    // One past the highest index handed out
+    uint32_t size() const { return count; }
+
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (uint32_t s = 0; s < maxSegments; s++)
+        {
+            if (segments[s])
+                total += allocationBytes(segmentSize(s) * sizeof(T));
+        }
+        return total;
+    }
+};
+
+// Usernames stored once each, addressed by 32-bit name id, with a hash index from name to
+// the owning user's id. A record is the owner id followed by the NUL-terminated name;
+// records live in an append-only arena, so readers can resolve a name id at any time.
+class NamePool
+{
+private:
+    static const uint32_t ownerBytes = sizeof(uint32_t);
+
+    SegmentedArray<char, 8> records;
+    vector<uint32_t> table; // open addressing over record offsets, sized to a power of two
+    uint32_t count;
+
+    static size_t hashOf(const char *s)
+    {
+        size_t h = 14695981039346656037ull;
+        for (; *s; s++)
+            h = (h ^ (unsigned char)*s) * 1099511628211ull;
+        return h;
+    }
+
+    uint32_t ownerOf(uint32_t record) const
+    {
+        uint32_t owner;
+        memcpy(&owner, &records[record], ownerBytes);
+        return owner;
+    }
+
+    // Table position holding `s`, or the empty position where it belongs
+    size_t probe(const char *s) const
+    {
+        size_t i = hashOf(s) & (table.size() - 1);
+        while (table[i] != none && strcmp(text(table[i]), s) != 0)
+            i = (i + 1) & (table.size() - 1);
+        return i;
+    }
+
+    void grow()
+    {
+        vector<uint32_t> old;
+        old.swap(table);
+        table.assign(old.empty() ? 16 : old.size() * 2, (uint32_t)none);
+        for (uint32_t record : old)
+        {
+            if (record != none)
+                table[probe(text(record))] = record;
+        }
+    }
+
+public:
+    static const uint32_t none = UINT32_MAX;
+
+    NamePool() : count(0) {}
+    NamePool(const NamePool &) = delete;
+    NamePool &operator=(const NamePool &) = delete;
+
+    // Id of the user owning `name`, or none
+    uint32_t find(const string &name) const
+    {
+        if (table.empty())
+            return none;
+        uint32_t record = table[probe(name.c_str())];
+        return record == none ? none : ownerOf(record);
+    }
+
+    // Name id for `name`, recording `owner` as its owner unless the name is already taken
+    uint32_t add(const string &name, uint32_t owner)
+    {
+        if ((count + 1) * 2 > table.size())
+            grow();
+        size_t i = probe(name.c_str());
+        if (table[i] != none)
+            return table[i];
+        string record(ownerBytes, '\0');
+        memcpy(&record[0], &owner, ownerBytes);
+        record.append(name.c_str(), name.size() + 1);
+        table[i] = records.append(record.data(), (uint32_t)record.size());
+        count++;
+        return table[i];
+    }
+
+    const char *text(uint32_t nameId) const { return &records[nameId + ownerBytes]; }
+
+    size_t bytes() const { return records.bytes() + allocationBytes(table.capacity() * sizeof(uint32_t)); }
+};
+
+// Immutable strings stored NUL-terminated, back to back, in an append-only arena and
+// addressed by 32-bit offset, so a string costs its length plus one byte instead of a
+// 32-byte std::string and a heap block for anything past the small-string buffer
+class TextArena
+{
+private:
+    SegmentedArray<char, 10> chars;
+
+public:
+    uint32_t add(const string &s) { return chars.append(s.c_str(), (uint32_t)s.size() + 1); }
+    const char *text(uint32_t textId) const { return &chars[textId]; }
+    size_t bytes() const { return chars.bytes(); }
+};
+
 class User;
+class Post;
+
+// Per-SocialMedia storage that user, post, name and text ids refer to
+struct Registry
+{
+    SegmentedArray<User *> users;
+    SegmentedArray<Post *> posts;
+    NamePool names;
+    TextArena texts; // post text
+};
+
 class Content
 {
 protected:
-    string text;
-    int likes;
+    uint32_t textId;   // Text in Registry::texts
+    atomic<int> likes; // read by feed readers while another thread likes the post
 
 public:
-    Content(string txt) : text(txt), likes(0) {}
-    Content(string txt, int like) : text(txt), likes(like) {}
+    Content(uint32_t txt) : textId(txt), likes(0) {}
+    Content(uint32_t txt, int like) : textId(txt), likes(like) {}
 
-    virtual void display() const = 0; // Polymorphic display method
+    virtual void display(const Registry &registry) const = 0; // Polymorphic display method
 
     void like() { likes++; }
 
-    string getText() const { return text; }
-    int getLikes() const { return likes; }
+    string getText(const Registry &registry) const { return registry.texts.text(textId); }
+    int getLikes() const { return likes.load(); }
 
-    virtual void saveToFile(ofstream &file) const = 0;
+    virtual void saveToFile(ofstream &file, const Registry &registry) const = 0;
 };
 
 class Post : public Content
 {
 private:
+    uint32_t id; // Index into Registry::posts
     User *author;
 
 public:
-    Post(string txt, User *auth) : Content(txt), author(auth) {}
-    Post(string txt, int like, User *auth) : Content(txt, like), author(auth) {}
+    Post(string txt, User *auth, Registry &registry) : Post(txt, 0, auth, registry) {}
+    Post(string txt, int like, User *auth, Registry &registry)
+        : Content(registry.texts.add(txt), like), id(registry.posts.push_back(this)), author(auth) {}
 
-    void display() const;
+    uint32_t getId() const { return id; }
+    User *getAuthor() const { return author; }
 
-    void saveToFile(ofstream &file) const;
+    void display(const Registry &registry) const;
 
-    static vector<Post *> loadFromFile(vector<User *> &users);
+    void saveToFile(ofstream &file, const Registry &registry) const;
+
+    static vector<Post *> loadFromFile(Registry &registry);
+};
+
+// One user's follow lists and posts as published to feed readers, by id. This is the
+// only copy of the lists: User holds its current view and SocialMedia publishes it
+// as-is. A view is never modified once a FeedSnapshot refers to it; User copies it
+// before the next change.
+struct UserView
+{
+    IdList following;
+    IdList followers;
+    IdList posts;
 };
 
 class User
 {
 private:
-    string username;
-    string password;
-    vector<User *> following;
-    vector<User *> followers;
+    shared_ptr<const UserView> view; // Current lists; writer-owned, published as-is
+    uint32_t id;                     // Index into Registry::users and slot in every FeedSnapshot
+    uint32_t nameId;                 // Username in Registry::names
+
+    // Copy-on-write access to the lists. Only writers publish and reclaim snapshots, so a
+    // view nothing else holds a reference to is invisible to readers and changed in place.
+    UserView &edit()
+    {
+        if (view.use_count() > 1)
+            view = make_shared<UserView>(*view);
+        return const_cast<UserView &>(*view);
+    }
+
+public:
+    User(string username, Registry &registry)
+        : view(make_shared<UserView>()), id(registry.users.push_back(this)),
+          nameId(registry.names.add(username, id)) {}
+
+    string getUsername(const Registry &registry) const { return registry.names.text(nameId); }
+
+    uint32_t getId() const { return id; }
+
+    const shared_ptr<const UserView> &getView() const { return view; }
+
+    void follow(User *user)
+    {
+        if (user && user != this && !isFollowing(user))
+        { // Prevent self-following and duplicate follows
+            edit().following.push_back(user->id);
+            user->addFollower(this); // Add this user to the followed user's followers
+        }
+    }
+
+    void unfollow(User *user)
+    {
+        if (isFollowing(user))
+        {
+            edit().following.remove(user->id);
+            user->edit().followers.remove(id);
+        }
+    }
+
+    // Add a follower
+    void addFollower(User *user)
+    {
+        if (!isFollowedBy(user))
+        { // Prevent duplicate followers
+            edit().followers.push_back(user->id);
+        }
+    }
+
+    // Check if already following a user
+    bool isFollowing(User *user) const
+    {
+        for (uint32_t u : view->following)
+        {
+            if (u == user->id)
+                return true;
+        }
+        return false;
+    }
+
+    // Check if followed by a user
+    bool isFollowedBy(User *user) const
+    {
+        for (uint32_t u : view->followers)
+        {
+            if (u == user->id)
+                return true;
+        }
+        return false;
+    }
+
+    void addPost(Post *post)
+    {
+        edit().posts.push_back(post->getId());
+    }
+
+    const IdList &getFollowing() const { return view->following; }
+    const IdList &getFollowers() const { return view->followers; }
+
+    const IdList &getPostIds() const { return view->posts; }
+
+    // Save the user to a CSV file from a published view, including the following and followers list
+    void saveToFile(ofstream &file, const UserView &published, const Registry &registry) const
+    {
+        file << registry.names.text(nameId) << ",";
+        for (uint32_t u : published.following)
+        {
+            file << registry.users[u]->getUsername(registry) << "|"; // Save following list
+        }
+        file << ","; // Separate followers
+        for (uint32_t u : published.followers)
+        {
+            file << registry.users[u]->getUsername(registry) << "|"; // Save followers list
+        }
+        file << endl;
+    }
+
+    static User *findUser(const Registry &registry, const string &username)
+    {
+        uint32_t owner = registry.names.find(username);
+        return owner == NamePool::none ? nullptr : registry.users[owner];
+    }
+    static vector<User *> loadFromFile(Registry &registry);
+};
+
+void Post ::display(const Registry &registry) const
+{
+    cout << "\033[1;34m" << author->getUsername(registry) << "'s Post: \033[0m" << "\033[1;37m" << getText(registry) << "\033[0m" << endl
+         << "\033[1;32m" << getLikes() << " likes\033[0m" << endl;
+}
+
+void Post ::saveToFile(ofstream &file, const Registry &registry) const
+{
+    file << author->getUsername(registry) << "," << getText(registry) << "," << getLikes() << endl;
+}
+vector<User *> User::loadFromFile(Registry &registry)
+{
+    vector<User *> users;
+    ifstream file("users.csv");
+    string line;
+    while (getline(file, line))
+    {
+        stringstream ss(line);
+        string username, followingList, followersList;
+        getline(ss, username, ',');
+        getline(ss, followingList, ',');
+        getline(ss, followersList, ',');
+
+        User *newUser = new User(username, registry);
+        users.push_back(newUser);
+    }
+
+    // After loading users, parse the following and followers lists
+    file.clear();
+    file.seekg(0);
+    int userIndex = 0;
+    while (getline(file, line))
+    {
+        stringstream ss(line);
+        string username, followingList, followersList;
+        getline(ss, username, ',');
+        getline(ss, followingList, ',');
+        getline(ss, followersList, ',');
+
+        User *currentUser = users[userIndex];
+
+        // Process following list
+        stringstream followStream(followingList);
+        string followedUsername;
+        while (getline(followStream, followedUsername, '|'))
+        {
+            User *followedUser = findUser(registry, followedUsername);
+            if (followedUser)
+                currentUser->follow(followedUser);
+        }
+
+        // Process followers list
+        stringstream followersStream(followersList);
+        string followerUsername;
+        while (getline(followersStream, followerUsername, '|'))
+        {
+            User *followerUser = findUser(registry, followerUsername);
+            if (followerUser)
+                followerUser->follow(currentUser);
+        }
+
+        userIndex++;
+    }
+    file.close();
+    return users;
+}
+
+vector<Post *> Post::loadFromFile(Registry &registry)
+{
     vector<Post *> posts;
+    ifstream file("posts.csv");
+    string line, username, content;
+    int likes;
+    while (getline(file, line))
+    {
+        stringstream ss(line);
+        getline(ss, username, ',');
+        getline(ss, content, ',');
+        ss >> likes;
+
+        User *author = User::findUser(registry, username);
+        if (author)
+        {
+            Post *post = new Post(content, likes, author, registry);
+            posts.push_back(post);
+            author->addPost(post);
+        }
+    }
+    file.close();
+    return posts;
+}
+
+// One published version of the follow graph and post index, stored as a radix tree
+// over user slots. A write copies only the nodes on the path to the changed user and
+// shares every other subtree with the previous version, so it costs O(log n).
+struct FeedSnapshot
+{
+    static const uint32_t radixBits = 5;
+    static const uint32_t fanout = 1u << radixBits;
+    static const uint32_t maxHeight = 6; // inner levels needed to cover 32-bit slots
+
+    struct Node
+    {
+        uint64_t version; // snapshot version that created the node; only it may modify it
+    };
+    struct Inner : Node
+    {
+        shared_ptr<const Node> children[fanout];
+    };
+    struct Leaf : Node
+    {
+        shared_ptr<const UserView> views[fanout];
+    };
+
+    shared_ptr<const Node> root;
+    uint32_t height = 0; // inner levels above the leaves
+    uint64_t version = 0;
+    size_t userCount = 0; // one past the highest slot published
+
+    // View in a slot, or nullptr if it was never published
+    const UserView *find(uint32_t slot) const
+    {
+        if (slot >= userCount)
+            return nullptr;
+        const Node *node = root.get();
+        for (uint32_t level = height; level > 0 && node; level--)
+            node = static_cast<const Inner *>(node)->children[(slot >> (radixBits * level)) & (fanout - 1)].get();
+        return node ? static_cast<const Leaf *>(node)->views[slot & (fanout - 1)].get() : nullptr;
+    }
+
+    const UserView &view(uint32_t slot) const { return *find(slot); }
+
+    // Calls f(slot, view) for every published user in slot order
+    template <class F>
+    void forEach(F f) const { forEach(root.get(), height, 0, f); }
+
+    // Number of inner and leaf nodes reachable from the root
+    void countNodes(size_t &inner, size_t &leaves) const { countNodes(root.get(), height, inner, leaves); }
+
+    // Writer side, on an unpublished copy whose version was bumped: point `slot` at `view`
+    void assign(uint32_t slot, const shared_ptr<const UserView> &view)
+    {
+        while (height < maxHeight && (slot >> (radixBits * (height + 1))) != 0)
+        {
+            auto grown = make_shared<Inner>();
+            grown->version = version;
+            grown->children[0] = root;
+            root = grown;
+            height++;
+        }
+        root = assign(root, height, slot, view);
+        userCount = max<size_t>(userCount, (size_t)slot + 1);
+    }
+
+private:
+    // Node that this version may modify: `node` itself if it was created by this version,
+    // otherwise a copy of it (or a fresh node when there is none yet)
+    template <class T>
+    shared_ptr<T> own(const shared_ptr<const Node> &node) const
+    {
+        if (node && node->version == version)
+            return const_pointer_cast<T>(static_pointer_cast<const T>(node));
+        auto copy = node ? make_shared<T>(*static_cast<const T *>(node.get())) : make_shared<T>();
+        copy->version = version;
+        return copy;
+    }
+
+    shared_ptr<const Node> assign(const shared_ptr<const Node> &node, uint32_t level, uint32_t slot, const shared_ptr<const UserView> &view)
+    {
+        uint32_t index = (slot >> (radixBits * level)) & (fanout - 1);
+        if (level == 0)
+        {
+            auto leaf = own<Leaf>(node);
+            leaf->views[index] = view;
+            return leaf;
+        }
+        auto inner = own<Inner>(node);
+        inner->children[index] = assign(inner->children[index], level - 1, slot, view);
+        return inner;
+    }
+
+    template <class F>
+    static void forEach(const Node *node, uint32_t level, uint32_t base, F &f)
+    {
+        if (!node)
+            return;
+        for (uint32_t i = 0; i < fanout; i++)
+        {
+            uint32_t slot = base | (i << (radixBits * level));
+            if (level == 0)
+            {
+                if (const UserView *view = static_cast<const Leaf *>(node)->views[i].get())
+                    f(slot, *view);
+            }
+            else
+                forEach(static_cast<const Inner *>(node)->children[i].get(), level - 1, slot, f);
+        }
+    }
+
+    static void countNodes(const Node *node, uint32_t level, size_t &inner, size_t &leaves)
+    {
+        if (!node)
+            return;
+        if (level == 0)
+        {
+            leaves++;
+            return;
+        }
+        inner++;
+        for (auto &child : static_cast<const Inner *>(node)->children)
+            countNodes(child.get(), level - 1, inner, leaves);
+    }
+};
+
+// Publishes FeedSnapshot versions to lock-free readers. Readers announce the epoch they
+// entered in a reader slot; a retired version is only deleted once every announced epoch
+// is newer than the one it was retired in. publish() must be serialised by the caller.
+class SnapshotStore
+{
+private:
+    static const int maxReaders = 128;
+
+    struct alignas(64) ReaderSlot
+    {
+        atomic<uint64_t> epoch{0}; // 0 means the slot is idle
+    };
+
+    atomic<const FeedSnapshot *> current;
+    atomic<uint64_t> globalEpoch{1};
+    mutable ReaderSlot readers[maxReaders];
+    vector<pair<uint64_t, const FeedSnapshot *>> retired;
+
+    uint64_t oldestReaderEpoch() const
+    {
+        uint64_t oldest = UINT64_MAX;
+        for (const ReaderSlot &r : readers)
+        {
+            uint64_t e = r.epoch.load();
+            if (e != 0 && e < oldest)
+                oldest = e;
+        }
+        return oldest;
+    }
+
+    void reclaim()
+    {
+        uint64_t oldest = oldestReaderEpoch();
+        auto keep = retired.begin();
+        for (auto &r : retired)
+        {
+            if (r.first < oldest)
+                delete r.second;
+            else
+                *keep++ = r;
+        }
+        retired.erase(keep, retired.end());
+    }
+
+public:
+    SnapshotStore() : current(new FeedSnapshot()) {}
+    SnapshotStore(const SnapshotStore &) = delete;
+    SnapshotStore &operator=(const SnapshotStore &) = delete;
+
+    ~SnapshotStore()
+    {
+        for (auto &r : retired)
+            delete r.second;
+        delete current.load();
+    }
+
+    // Claim a reader slot and announce the current epoch; returns the slot index
+    int enter() const
+    {
+        static atomic<unsigned> nextHint(0);
+        thread_local unsigned hint = nextHint.fetch_add(1);
+        while (true)
+        {
+            for (int i = 0; i < maxReaders; i++)
+            {
+                ReaderSlot &r = readers[(hint + i) % maxReaders];
+                uint64_t idle = 0;
+                if (r.epoch.load(memory_order_relaxed) == 0 && r.epoch.compare_exchange_strong(idle, globalEpoch.load()))
+                    return (hint + i) % maxReaders;
+            }
+            this_thread::yield();
+        }
+    }
+
+    // Must be called after enter(): the announced epoch keeps the result alive
+    const FeedSnapshot *acquire() const { return current.load(); }
+
+    void leave(int slot) const { readers[slot].epoch.store(0, memory_order_release); }
+
+    // Writer-side view of the newest version, used as the base for the next one
+    const FeedSnapshot *latest() const { return current.load(); }
+
+    void publish(const FeedSnapshot *next)
+    {
+        const FeedSnapshot *old = current.exchange(next);
+        retired.push_back({globalEpoch.fetch_add(1), old});
+        reclaim();
+    }
+};
+
+// RAII pin on the newest snapshot; hold it only as long as the snapshot is dereferenced
+class SnapshotReader
+{
+private:
+    const SnapshotStore &store;
+    int slot;
+    const FeedSnapshot *snapshot;
+
+public:
+    SnapshotReader(const SnapshotStore &s) : store(s), slot(s.enter()), snapshot(s.acquire()) {}
+    ~SnapshotReader() { store.leave(slot); }
+    SnapshotReader(const SnapshotReader &) = delete;
+    SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+    const FeedSnapshot *operator->() const { return snapshot; }
+};
+
+// Order-statistics tree (a treap with subtree sizes) ranking user slots by a score,
+// highest first, ties broken by slot. Nodes live in a pool indexed by slot and link
+// to each other by 32-bit index. set and rank are O(log n) expected; top(n) is
+// O(log n + n). Callers keep it in step with the score source.
+class Leaderboard
+{
+private:
+    static const uint32_t nil = UINT32_MAX;
+
+    struct Node
+    {
+        long long score;
+        uint32_t priority;
+        uint32_t size; // 0 while the slot is not ranked
+        uint32_t left;
+        uint32_t right;
+    };
+
+    vector<Node> nodes;
+    uint32_t root;
+    size_t count;
+
+    // Treap priority: a fixed hash of the slot, as good as a random one here and stateless
+    static uint32_t priorityOf(uint32_t slot)
+    {
+        uint32_t h = slot * 2654435761u;
+        h = (h ^ (h >> 16)) * 0x45d9f3bu;
+        return h ^ (h >> 16);
+    }
+
+    uint32_t sizeOf(uint32_t n) const { return n == nil ? 0 : nodes[n].size; }
+    void pull(uint32_t n) { nodes[n].size = 1 + sizeOf(nodes[n].left) + sizeOf(nodes[n].right); }
+
+    // True if (score, slot) ranks ahead of n
+    bool ranksBefore(long long score, uint32_t slot, uint32_t n) const
+    {
+        if (score != nodes[n].score)
+            return score > nodes[n].score;
+        return slot < n;
+    }
+
+    // l receives every node ranking ahead of (score, slot), r the rest
+    void split(uint32_t n, long long score, uint32_t slot, uint32_t &l, uint32_t &r)
+    {
+        if (n == nil)
+        {
+            l = r = nil;
+            return;
+        }
+        if (ranksBefore(score, slot, n))
+        {
+            split(nodes[n].left, score, slot, l, nodes[n].left);
+            r = n;
+        }
+        else
+        {
+            split(nodes[n].right, score, slot, nodes[n].right, r);
+            l = n;
+        }
+        pull(n);
+    }
+
+    uint32_t merge(uint32_t l, uint32_t r)
+    {
+        if (l == nil || r == nil)
+            return l == nil ? r : l;
+        if (nodes[l].priority > nodes[r].priority)
+        {
+            nodes[l].right = merge(nodes[l].right, r);
+            pull(l);
+            return l;
+        }
+        nodes[r].left = merge(l, nodes[r].left);
+        pull(r);
+        return r;
+    }
+
+    void insert(uint32_t &n, uint32_t item)
+    {
+        if (n == nil)
+            n = item;
+        else if (nodes[item].priority > nodes[n].priority)
+        {
+            split(n, nodes[item].score, item, nodes[item].left, nodes[item].right);
+            n = item;
+        }
+        else
+            insert(ranksBefore(nodes[item].score, item, n) ? nodes[n].left : nodes[n].right, item);
+        pull(n);
+    }
+
+    void erase(uint32_t &n, uint32_t item)
+    {
+        if (n == item)
+        {
+            n = merge(nodes[item].left, nodes[item].right);
+            return;
+        }
+        erase(ranksBefore(nodes[item].score, item, n) ? nodes[n].left : nodes[n].right, item);
+        pull(n);
+    }
+
+    void collect(uint32_t n, size_t limit, vector<pair<uint32_t, long long>> &out) const
+    {
+        if (n == nil || out.size() >= limit)
+            return;
+        collect(nodes[n].left, limit, out);
+        if (out.size() < limit)
+            out.push_back({n, nodes[n].score});
+        collect(nodes[n].right, limit, out);
+    }
 
 public:
-    User(string name) : username(name) {}
+    Leaderboard() : root(nil), count(0) {}
+
+    size_t size() const { return count; }
+    size_t bytes() const { return allocationBytes(nodes.capacity() * sizeof(Node)); }
+
+    // Ranks `slot` with `score`, moving it if it is already ranked
+    void set(uint32_t slot, long long score)
+    {
+        if (slot >= nodes.size())
+        {
+            if (slot >= nodes.capacity())
+                nodes.reserve(slot + 1 + slot / 8); // a node per user: grow by an eighth, not double
+            nodes.resize(slot + 1, Node{0, 0, 0, nil, nil});
+        }
+        Node &node = nodes[slot];
+        if (node.size != 0)
+        {
+            if (node.score == score)
+                return;
+            erase(root, slot);
+        }
+        else
+        {
+            node.priority = priorityOf(slot);
+            count++;
+        }
+        node.score = score;
+        node.size = 1;
+        node.left = node.right = nil;
+        insert(root, slot);
+    }
+
+    long long score(uint32_t slot) const { return slot < nodes.size() ? nodes[slot].score : 0; }
+
+    // 1-based position of `slot`, or 0 if it is not ranked
+    size_t rank(uint32_t slot) const
+    {
+        if (slot >= nodes.size() || nodes[slot].size == 0)
+            return 0;
+        size_t ahead = 0;
+        uint32_t n = root;
+        while (n != slot)
+        {
+            if (ranksBefore(nodes[slot].score, slot, n))
+                n = nodes[n].left;
+            else
+            {
+                ahead += sizeOf(nodes[n].left) + 1;
+                n = nodes[n].right;
+            }
+        }
+        return ahead + sizeOf(nodes[slot].left) + 1;
+    }
+
+    // Up to `limit` (slot, score) pairs from the top
+    vector<pair<uint32_t, long long>> top(size_t limit) const
+    {
+        vector<pair<uint32_t, long long>> out;
+        collect(root, limit, out);
+        return out;
+    }
+};
+
+// A user's counts, likes and leaderboard ranks, read together under the write lock so
+// the ranks always agree with the counts shown next to them
+struct ProfileStats
+{
+    size_t following = 0;
+    size_t followers = 0;
+    size_t posts = 0;
+    long long likes = 0;
+    size_t followerRank = 0;
+    size_t likeRank = 0;
+};
 
-    string getUsername() const { return username; }
+// Bytes held by a SocialMedia instance, by category, including allocator overhead as
+// modelled by allocationBytes(). Snapshot versions awaiting reclamation are excluded.
+struct MemoryStats
+{
+    size_t strings = 0;   // username records and the name index
+    size_t edges = 0;     // follow ids, both directions
+    size_t edgeLists = 0; // per-user follow list headers and unused inline slots
+    size_t posts = 0;     // post objects, their text, the post directory and per-user post lists
+    size_t overhead = 0;  // the instance, user objects and views, user directory, snapshot tree, leaderboards
+    size_t userCount = 0;
+    size_t edgeCount = 0;
+    size_t postCount = 0;
+
+    size_t total() const { return strings + edges + edgeLists + posts + overhead; }
+};
 
-    void follow(User *user)
+class SocialMedia
+{
+private:
+    Registry registry;
+    bool persistent;         // false for in-memory instances that never touch the CSV files
+    mutable mutex writeLock; // serialises writers and leaderboard queries; readers pin snapshots
+    mutable mutex fileLock;  // serialises CSV rewrites, which read a pinned snapshot
+    SnapshotStore snapshots;
+    Leaderboard followerBoard; // scored by followers count
+    Leaderboard likeBoard;     // scored by total likes received, the only copy of that aggregate
+
+    // Caller holds writeLock and has already published the users' snapshot slots. A user's
+    // likes received start as the sum over their posts; likePost keeps it current after that.
+    void rankUsers(const vector<User *> &added)
     {
-        if (user && user != this && !isFollowing(user))
-        { // Prevent self-following and duplicate follows
-            following.push_back(user);
-            user->addFollower(this); // Add this user to the followed user's followers
+        for (User *u : added)
+        {
+            followerBoard.set(u->getId(), u->getFollowers().size());
+            long long likes = 0;
+            for (uint32_t p : u->getPostIds())
+                likes += registry.posts[p]->getLikes();
+            likeBoard.set(u->getId(), likes);
         }
     }
 
-    // Add a follower
-    void addFollower(User *user)
+    // Caller holds writeLock
+    vector<pair<User *, long long>> resolve(const vector<pair<uint32_t, long long>> &ranked) const
     {
-        if (!isFollowedBy(user))
-        { // Prevent duplicate followers
-            followers.push_back(user);
-        }
+        vector<pair<User *, long long>> out;
+        for (auto &entry : ranked)
+            out.push_back({registry.users[entry.first], entry.second});
+        return out;
     }
 
-    // Check if already following a user
-    bool isFollowing(User *user) const
+    // Copy-on-write: path-copy the changed users' views into a new tree version that
+    // shares everything else with the previous one. Caller holds writeLock.
+    void republish(const vector<User *> &changed)
+    {
+        FeedSnapshot *next = new FeedSnapshot(*snapshots.latest());
+        next->version++;
+        for (User *u : changed)
+            next->assign(u->getId(), u->getView());
+        snapshots.publish(next);
+    }
+
+public:
+    SocialMedia(bool persist = true) : persistent(persist)
     {
-        for (User *u : following)
+        vector<User *> loaded;
+        if (persistent)
         {
-            if (u == user)
-                return true;
+            loaded = User::loadFromFile(registry);
+            Post::loadFromFile(registry);
         }
-        return false;
+        lock_guard<mutex> lock(writeLock);
+        republish(loaded);
+        rankUsers(loaded);
     }
 
-    // Check if followed by a user
-    bool isFollowedBy(User *user) const
+    User *addUser(string username)
+    {
+        vector<User *> added = addUsers({username});
+        return added.empty() ? nullptr : added[0];
+    }
+
+    // Adds every name not already taken and publishes them as one snapshot version
+    vector<User *> addUsers(const vector<string> &usernames)
     {
-        for (User *u : followers)
+        vector<User *> added;
         {
-            if (u == user)
-                return true;
+            lock_guard<mutex> lock(writeLock);
+            for (const string &username : usernames)
+            {
+                if (findUser(username))
+                {
+                    cout << "User with username " << username << " already exists." << endl;
+                    continue;
+                }
+                added.push_back(new User(username, registry));
+            }
+            republish(added);
+            rankUsers(added);
         }
-        return false;
+        saveUsersToFile();
+        return added;
     }
 
-    void addPost(Post *post)
+    User *findUser(string username) const
     {
-        posts.push_back(post);
+        return User::findUser(registry, username);
     }
 
-    vector<User *> &getFollowing() { return following; }
-    vector<User *> &getFollowers() { return followers; }
-
-    vector<Post *> getContents() const { return posts; }
+    string getUsername(const User *user) const
+    {
+        return user->getUsername(registry);
+    }
 
-    void displayProfile() const
+    void followUser(User *user, User *target)
     {
-        cout << "\033[1;34mUser: \033[0m" << username << endl;
-        cout << "\033[1;32mFollowing: \033[0m" << this->following.size() << endl;
-        cout << "\033[1;32mFollowers: \033[0m" << this->followers.size() << endl;
-        cout << "\033[1;32mTotal posts: \033[0m" << this->posts.size() << endl;
+        lock_guard<mutex> lock(writeLock);
+        user->follow(target);
+        followerBoard.set(target->getId(), target->getFollowers().size());
+        republish({user, target});
     }
 
-    void displayFollowers() const
+    // Applies many follows and publishes them as one snapshot version
+    void followUsers(const vector<pair<User *, User *>> &edges)
     {
-        cout << "\033[1;33mFollowers: \033[0m";
-        for (auto u : followers)
+        lock_guard<mutex> lock(writeLock);
+        vector<User *> changed;
+        for (auto &edge : edges)
         {
-            cout << u->getUsername() << endl;
+            edge.first->follow(edge.second);
+            followerBoard.set(edge.second->getId(), edge.second->getFollowers().size());
+            changed.push_back(edge.first);
+            changed.push_back(edge.second);
         }
-        cout << endl;
+        sort(changed.begin(), changed.end());
+        changed.erase(unique(changed.begin(), changed.end()), changed.end());
+        republish(changed);
     }
 
-    void displayFollowing() const
+    void unfollowUser(User *user, User *target)
+    {
+        lock_guard<mutex> lock(writeLock);
+        user->unfollow(target);
+        followerBoard.set(target->getId(), target->getFollowers().size());
+        republish({user, target});
+    }
+
+    void likePost(Post *post)
     {
-        cout << "\033[1;33mFollowing: \033[0m";
-        for (auto u : following)
         {
-            cout << u->getUsername() << endl;
+            lock_guard<mutex> lock(writeLock);
+            User *author = post->getAuthor();
+            post->like();
+            likeBoard.set(author->getId(), likeBoard.score(author->getId()) + 1);
         }
-        cout << endl;
+        savePostsToFile();
+    }
+
+    // Top `limit` users by followers count
+    vector<pair<User *, long long>> topByFollowers(size_t limit) const
+    {
+        lock_guard<mutex> lock(writeLock);
+        return resolve(followerBoard.top(limit));
+    }
+
+    // Top `limit` users by total likes received
+    vector<pair<User *, long long>> topByLikes(size_t limit) const
+    {
+        lock_guard<mutex> lock(writeLock);
+        return resolve(likeBoard.top(limit));
+    }
+
+    size_t followerRank(User *user) const
+    {
+        lock_guard<mutex> lock(writeLock);
+        return followerBoard.rank(user->getId());
     }
 
-    void displayContents() const
+    size_t likeRank(User *user) const
+    {
+        lock_guard<mutex> lock(writeLock);
+        return likeBoard.rank(user->getId());
+    }
+
+    void createPost(User *user, string content)
     {
-        if (posts.empty())
         {
-            cout << "\033[1;31mNo posts to display!\033[0m" << endl;
+            lock_guard<mutex> lock(writeLock);
+            user->addPost(new Post(content, user, registry));
+            republish({user});
         }
-        else
+        savePostsToFile();
+    }
+
+    // Creates many posts and publishes them as one snapshot version
+    void createPosts(const vector<pair<User *, string>> &contents)
+    {
         {
-            cout << "\033[1;36mAll posts: \033[0m" << endl;
-            for (auto post : posts)
+            lock_guard<mutex> lock(writeLock);
+            vector<User *> changed;
+            for (auto &item : contents)
             {
-                post->display();
+                item.first->addPost(new Post(item.second, item.first, registry));
+                changed.push_back(item.first);
             }
-            cout << endl;
+            sort(changed.begin(), changed.end());
+            changed.erase(unique(changed.begin(), changed.end()), changed.end());
+            republish(changed);
         }
+        savePostsToFile();
     }
-    // Save the user to a CSV file, including the following and followers list
-    void saveToFile(ofstream &file) const
+
+    bool isFollowing(User *user, User *target) const
     {
-        file << username << ",";
-        for (User *u : following)
-        {
-            file << u->getUsername() << "|"; // Save following list
-        }
-        file << ","; // Separate followers
-        for (User *u : followers)
+        SnapshotReader snap(snapshots);
+        for (uint32_t u : snap->view(user->getId()).following)
         {
-            file << u->getUsername() << "|"; // Save followers list
+            if (u == target->getId())
+                return true;
         }
-        file << endl;
+        return false;
     }
 
-    static User *findUser(const vector<User *> &users, const string &username)
+    // Unlike the listings this takes writeLock, trading the lock-free read for counts
+    // that match the ranks shown next to them
+    ProfileStats profileStats(User *user) const
     {
-        for (User *u : users)
-        {
-            if (u->getUsername() == username)
-                return u;
-        }
-        return nullptr;
+        lock_guard<mutex> lock(writeLock);
+        ProfileStats stats;
+        stats.following = user->getFollowing().size();
+        stats.followers = user->getFollowers().size();
+        stats.posts = user->getPostIds().size();
+        stats.likes = likeBoard.score(user->getId());
+        stats.followerRank = followerBoard.rank(user->getId());
+        stats.likeRank = likeBoard.rank(user->getId());
+        return stats;
     }
-    static vector<User *> loadFromFile();
-};
-
-void Post ::display() const
-{
-    cout << "\033[1;34m" << author->getUsername() << "'s Post: \033[0m" << "\033[1;37m" << text << "\033[0m" << endl
-         << "\033[1;32m" << likes << " likes\033[0m" << endl;
-}
 
-void Post ::saveToFile(ofstream &file) const
-{
-    file << author->getUsername() << "," << text << "," << likes << endl;
-}
-vector<User *> User::loadFromFile()
-{
-    vector<User *> users;
-    ifstream file("users.csv");
-    string line;
-    while (getline(file, line))
+    void displayProfile(User *user) const
     {
-        stringstream ss(line);
-        string username, followingList, followersList;
-        getline(ss, username, ',');
-        getline(ss, followingList, ',');
-        getline(ss, followersList, ',');
-
-        User *newUser = new User(username);
-        users.push_back(newUser);
+        ProfileStats stats = profileStats(user);
+        cout << "\033[1;34mUser: \033[0m" << user->getUsername(registry) << endl;
+        cout << "\033[1;32mFollowing: \033[0m" << stats.following << endl;
+        cout << "\033[1;32mFollowers: \033[0m" << stats.followers << endl;
+        cout << "\033[1;32mTotal posts: \033[0m" << stats.posts << endl;
+        cout << "\033[1;32mTotal likes: \033[0m" << stats.likes << endl;
+        cout << "\033[1;32mRank: \033[0m#" << stats.followerRank << " by followers, #" << stats.likeRank << " by likes" << endl;
     }
 
-    // After loading users, parse the following and followers lists
-    file.clear();
-    file.seekg(0);
-    int userIndex = 0;
-    while (getline(file, line))
+    void displayLeaderboards(size_t limit) const
     {
-        stringstream ss(line);
-        string username, followingList, followersList;
-        getline(ss, username, ',');
-        getline(ss, followingList, ',');
-        getline(ss, followersList, ',');
-
-        User *currentUser = users[userIndex];
-
-        // Process following list
-        stringstream followStream(followingList);
-        string followedUsername;
-        while (getline(followStream, followedUsername, '|'))
+        cout << "\033[1;34m--------- Most Followed ----------\033[0m" << endl;
+        int position = 1;
+        for (auto &entry : topByFollowers(limit))
         {
-            User *followedUser = findUser(users, followedUsername);
-            if (followedUser)
-                currentUser->follow(followedUser);
+            cout << "\033[1;33m" << position++ << ". \033[0m" << entry.first->getUsername(registry)
+                 << " \033[1;32m(" << entry.second << " followers)\033[0m" << endl;
         }
-
-        // Process followers list
-        stringstream followersStream(followersList);
-        string followerUsername;
-        while (getline(followersStream, followerUsername, '|'))
+        cout << endl
+             << "\033[1;34m--------- Most Liked ----------\033[0m" << endl;
+        position = 1;
+        for (auto &entry : topByLikes(limit))
         {
-            User *followerUser = findUser(users, followerUsername);
-            if (followerUser)
-                followerUser->follow(currentUser);
+            cout << "\033[1;33m" << position++ << ". \033[0m" << entry.first->getUsername(registry)
+                 << " \033[1;32m(" << entry.second << " likes)\033[0m" << endl;
         }
-
-        userIndex++;
+        cout << endl;
     }
-    file.close();
-    return users;
-}
 
-vector<Post *> Post::loadFromFile(vector<User *> &users)
-{
-    vector<Post *> posts;
-    ifstream file("posts.csv");
-    string line, username, content;
-    int likes;
-    while (getline(file, line))
+    void displayFollowers(User *user) const
     {
-        stringstream ss(line);
-        getline(ss, username, ',');
-        getline(ss, content, ',');
-        ss >> likes;
-
-        User *author = User::findUser(users, username);
-        if (author)
+        SnapshotReader snap(snapshots);
+        cout << "\033[1;33mFollowers: \033[0m";
+        for (uint32_t u : snap->view(user->getId()).followers)
         {
-            Post *post = new Post(content, likes, author);
-            posts.push_back(post);
-            author->addPost(post);
+            cout << registry.users[u]->getUsername(registry) << endl;
         }
+        cout << endl;
     }
-    file.close();
-    return posts;
-}
-
-class SocialMedia
-{
-private:
-    vector<User *> users;
-    vector<Post *> posts;
 
-public:
-    SocialMedia()
+    void displayFollowing(User *user) const
     {
-        users = User::loadFromFile();
-        posts = Post::loadFromFile(users);
+        SnapshotReader snap(snapshots);
+        cout << "\033[1;33mFollowing: \033[0m";
+        for (uint32_t u : snap->view(user->getId()).following)
+        {
+            cout << registry.users[u]->getUsername(registry) << endl;
+        }
+        cout << endl;
     }
 
-    void addUser(string username)
+    void displayContents(User *user) const
     {
-        if (findUser(username))
+        vector<Post *> userPosts = collectUserPosts(user);
+        if (userPosts.empty())
         {
-            cout << "User with username " << username << " already exists." << endl;
+            cout << "\033[1;31mNo posts to display!\033[0m" << endl;
         }
         else
         {
-            User *newUser = new User(username);
-            users.push_back(newUser);
-            saveUsersToFile();
+            cout << "\033[1;36mAll posts: \033[0m" << endl;
+            for (Post *post : userPosts)
+            {
+                post->display(registry);
+            }
+            cout << endl;
         }
     }
-    void sortUsersByFollowers()
+
+    // Posts of every user in the newest snapshot, in user order
+    vector<Post *> collectPublicFeed() const
     {
-        sort(users.begin(), users.end(), [](User *a, User *b)
-             { return a->getFollowers().size() > b->getFollowers().size(); });
+        vector<Post *> allPosts;
+        SnapshotReader snap(snapshots);
+        snap->forEach([&](uint32_t, const UserView &view)
+                      {
+            for (uint32_t p : view.posts)
+                allPosts.push_back(registry.posts[p]); });
+        return allPosts;
     }
-    User *findUser(string username) const
+
+    // Posts written by `user` in the newest snapshot
+    vector<Post *> collectUserPosts(User *user) const
     {
-        for (User *u : users)
-        {
-            if (u->getUsername() == username)
-                return u;
-        }
-        return nullptr;
+        vector<Post *> userPosts;
+        SnapshotReader snap(snapshots);
+        for (uint32_t p : snap->view(user->getId()).posts)
+            userPosts.push_back(registry.posts[p]);
+        return userPosts;
     }
 
-    void createPost(User *user, string content)
+    // Posts of the users `user` follows in the newest snapshot
+    vector<Post *> collectFollowedFeed(User *user) const
     {
-        Post *newPost = new Post(content, user);
-        posts.push_back(newPost);
-        user->addPost(newPost);
-        savePostsToFile();
+        vector<Post *> followedPosts;
+        SnapshotReader snap(snapshots);
+        for (uint32_t followed : snap->view(user->getId()).following)
+        {
+            for (uint32_t p : snap->view(followed).posts)
+                followedPosts.push_back(registry.posts[p]);
+        }
+        return followedPosts;
     }
+
     void displaySinglePost(Post *post) const
     {
         if (post)
         {
             system("clear");
-            post->display();
+            post->display(registry);
             cout << "\033[1;36m1. Like\n2. Next\n3. Previous\n4. Home\033[0m" << endl;
         }
     }
 
-    void displayPublicFeed() const
+    void displayPublicFeed()
     {
         int currentIndex = 0;
-        vector<Post *> allPosts;
-
-        // Collect all posts
-        for (User *user : users)
-        {
-            vector<Post *> userPosts = user->getContents();
-            allPosts.insert(allPosts.end(), userPosts.begin(), userPosts.end());
-        }
+        vector<Post *> allPosts = collectPublicFeed();
 
         if (allPosts.empty())
         {
@@ -358,8 +1349,7 @@ public:
             switch (choice)
             {
             case 1:
-                allPosts[currentIndex]->like();
-                savePostsToFile();
+                likePost(allPosts[currentIndex]);
                 break;
             case 2:
                 if (currentIndex < allPosts.size() - 1)
@@ -387,18 +1377,11 @@ public:
         }
     }
 
-    void displayFollowedFeed(User *user) const
+    void displayFollowedFeed(User *user)
     {
-        vector<Post *> followedPosts;
+        vector<Post *> followedPosts = collectFollowedFeed(user);
         int currentIndex = 0;
 
-        // Collect posts from followed users
-        for (User *followed : user->getFollowing())
-        {
-            vector<Post *> userPosts = followed->getContents();
-            followedPosts.insert(followedPosts.end(), userPosts.begin(), userPosts.end());
-        }
-
         if (followedPosts.empty())
         {
             cout << "\033[1;31mNo posts from followed users!\033[0m" << endl;
@@ -419,8 +1402,7 @@ public:
             switch (choice)
             {
             case 1:
-                followedPosts[currentIndex]->like();
-                savePostsToFile();
+                likePost(followedPosts[currentIndex]);
                 break;
             case 2:
                 if (currentIndex < followedPosts.size() - 1)
@@ -451,29 +1433,309 @@ public:
         }
     }
 
-    void saveUsersToFile() const
+    MemoryStats memoryStats() const
     {
-        ofstream file("users.csv", ios::out);
-        for (User *u : users)
+        // make_shared's reference counts and vtable pointer on a typical 64-bit ABI
+        const size_t sharedBlockBytes = 16;
+
+        lock_guard<mutex> lock(writeLock);
+        MemoryStats stats;
+        stats.overhead += sizeof(SocialMedia);
+        stats.userCount = registry.users.size();
+        stats.postCount = registry.posts.size();
+
+        stats.strings += registry.names.bytes();
+
+        stats.overhead += registry.users.bytes();
+        for (uint32_t id = 0; id < registry.users.size(); id++)
+        {
+            const User *u = registry.users[id];
+            const UserView &view = *u->getView();
+            stats.edgeCount += view.following.size();
+            stats.edges += view.following.itemBytes() + view.followers.itemBytes();
+            stats.edgeLists += view.following.headerBytes() + view.followers.headerBytes();
+            stats.posts += view.posts.headerBytes() + view.posts.itemBytes();
+            stats.overhead += allocationBytes(sizeof(User)) + allocationBytes(sharedBlockBytes + sizeof(UserView)) - 3 * sizeof(IdList);
+        }
+
+        stats.posts += registry.posts.bytes();
+        for (uint32_t id = 0; id < registry.posts.size(); id++)
+            stats.posts += allocationBytes(sizeof(Post));
+        stats.posts += registry.texts.bytes();
+
+        size_t inner = 0, leaves = 0;
+        const FeedSnapshot *snap = snapshots.latest();
+        snap->countNodes(inner, leaves);
+        stats.overhead += allocationBytes(sizeof(FeedSnapshot)) + inner * allocationBytes(sharedBlockBytes + sizeof(FeedSnapshot::Inner)) +
+                          leaves * allocationBytes(sharedBlockBytes + sizeof(FeedSnapshot::Leaf));
+
+        stats.overhead += followerBoard.bytes() + likeBoard.bytes();
+        return stats;
+    }
+
+    void displayMemoryStats() const
+    {
+        MemoryStats stats = memoryStats();
+        cout << "Memory footprint: " << stats.userCount << " users, " << stats.edgeCount << " follow edges, "
+             << stats.postCount << " posts (including allocator overhead)" << endl;
+        cout << "  strings\t" << stats.strings << " bytes" << endl;
+        cout << "  edges\t\t" << stats.edges << " bytes" << endl;
+        cout << "  edge lists\t" << stats.edgeLists << " bytes" << endl;
+        cout << "  posts\t\t" << stats.posts << " bytes" << endl;
+        cout << "  overhead\t" << stats.overhead << " bytes" << endl;
+        cout << "  total\t\t" << stats.total() << " bytes" << endl;
+        if (stats.userCount)
         {
-            u->saveToFile(file);
+            cout << "  per user\t" << (double)stats.total() / stats.userCount << " bytes, of which "
+                 << (double)stats.edgeLists / stats.userCount << " in edge list headers" << endl;
         }
+        if (stats.edgeCount)
+            cout << "  per edge\t" << (double)stats.edges / stats.edgeCount << " bytes of ids (each edge is stored once per direction)" << endl;
+        if (stats.postCount)
+            cout << "  per post\t" << (double)stats.posts / stats.postCount << " bytes" << endl;
+    }
+
+    // Rewrites users.csv from a pinned snapshot, so writers are never held up by disk
+    // I/O. fileLock orders concurrent rewrites; each pins after taking it, so the file
+    // always ends up holding the newest version.
+    void saveUsersToFile() const
+    {
+        if (!persistent)
+            return;
+        lock_guard<mutex> lock(fileLock);
+        SnapshotReader snap(snapshots);
+        ofstream file("users.csv", ios::out);
+        snap->forEach([&](uint32_t id, const UserView &view)
+                      { registry.users[id]->saveToFile(file, view, registry); });
         file.close();
     }
 
+    // Rewrites posts.csv from a pinned snapshot, grouped by author in user order
     void savePostsToFile() const
     {
+        if (!persistent)
+            return;
+        lock_guard<mutex> lock(fileLock);
+        SnapshotReader snap(snapshots);
         ofstream file("posts.csv", ios::out);
-        for (Post *p : posts)
-        {
-            p->saveToFile(file);
-        }
+        snap->forEach([&](uint32_t, const UserView &view)
+                      {
+            for (uint32_t p : view.posts)
+                registry.posts[p]->saveToFile(file, registry); });
         file.close();
     }
 };
 
-int main()
+// Builds an in-memory network of `userCount` users with heavy-tailed follow degrees
+// (most users follow one or two others) and a few posts each, then reports its footprint
+void runMemoryReport(int userCount)
+{
+    SocialMedia app(false);
+    vector<string> names;
+    for (int i = 0; i < userCount; i++)
+        names.push_back("user" + to_string(i));
+    vector<User *> people = app.addUsers(names);
+
+    mt19937 rng(99);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<pair<User *, User *>> edges;
+    vector<pair<User *, string>> contents;
+    for (User *u : people)
+    {
+        // Pareto-distributed degree with mean 2, capped to keep the tail finite
+        int degree = min(1000, (int)(1.0 / sqrt(1.0 - unit(rng))));
+        for (int j = 0; j < degree; j++)
+            edges.push_back({u, people[rng() % 2 ? rng() % max(1, userCount / 100) : rng() % userCount]});
+        for (int j = rng() % 4; j > 0; j--)
+            contents.push_back({u, "post " + to_string(j) + " by " + app.getUsername(u)});
+    }
+    app.followUsers(edges);
+    app.createPosts(contents);
+    app.displayMemoryStats();
+}
+
+// Reader-heavy mixed workload (95% followed-feed reads, 5% follows/posts) on an
+// in-memory instance, repeated for doubling thread counts to show read scaling
+void runFeedBenchmark()
+{
+    const int userCount = 10000;
+    const int followsPerUser = 20;
+    const int postsPerUser = 2;
+    const int opsPerThread = 200000;
+
+    SocialMedia app(false);
+    vector<User *> people;
+    mt19937 rng(42);
+    for (int i = 0; i < userCount; i++)
+        people.push_back(app.addUser("user" + to_string(i)));
+    for (User *u : people)
+    {
+        for (int j = 0; j < followsPerUser; j++)
+            app.followUser(u, people[rng() % userCount]);
+        for (int j = 0; j < postsPerUser; j++)
+            app.createPost(u, "post " + to_string(j) + " by " + app.getUsername(u));
+    }
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    vector<unsigned> threadCounts;
+    for (unsigned t = 1; t < maxThreads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+
+    cout << "feed benchmark: " << userCount << " users, " << opsPerThread << " ops/thread, 95% reads" << endl;
+    cout << "threads\tops/sec\t\tspeedup" << endl;
+    double baseline = 0;
+    atomic<size_t> checksum(0);
+    for (unsigned threadCount : threadCounts)
+    {
+        auto worker = [&](unsigned seed)
+        {
+            mt19937 local(seed);
+            size_t seen = 0;
+            for (int i = 0; i < opsPerThread; i++)
+            {
+                User *u = people[local() % userCount];
+                if (local() % 100 < 5)
+                {
+                    if (local() % 2)
+                        app.followUser(u, people[local() % userCount]);
+                    else
+                        app.createPost(u, "bench post");
+                }
+                else
+                {
+                    seen += app.collectFollowedFeed(u).size();
+                }
+            }
+            checksum += seen;
+        };
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (unsigned t = 0; t < threadCount; t++)
+            threads.emplace_back(worker, t + 1);
+        for (thread &t : threads)
+            t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        double opsPerSec = threadCount * (double)opsPerThread / seconds;
+        if (baseline == 0)
+            baseline = opsPerSec;
+        cout << threadCount << "\t" << (long long)opsPerSec << "\t\t" << opsPerSec / baseline << "x" << endl;
+    }
+    cout << "posts seen: " << checksum.load() << endl;
+}
+
+// Aggregate maintenance and leaderboard latency at 1M users, with a full sort of the
+// user list (what ranking used to cost) as the baseline
+void runLeaderboardBenchmark()
+{
+    const int userCount = 1000000;
+    const int updates = 50000;
+    const int queries = 100000;
+
+    auto nanosPerOp = [](chrono::steady_clock::time_point start, int ops)
+    {
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / ops;
+    };
+
+    SocialMedia app(false);
+    vector<string> names;
+    for (int i = 0; i < userCount; i++)
+        names.push_back("user" + to_string(i));
+    vector<User *> people = app.addUsers(names);
+    mt19937 rng(7);
+
+    // Half of all follows and likes go to a small set of popular users
+    auto pick = [&]()
+    {
+        return people[rng() % 2 ? rng() % 1000 : rng() % userCount];
+    };
+
+    cout << "leaderboard benchmark: " << userCount << " users" << endl;
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < updates; i++)
+        app.followUser(people[rng() % userCount], pick());
+    cout << "follow (incl. snapshot publish):\t" << nanosPerOp(start, updates) << " ns/op" << endl;
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < updates; i++)
+        app.createPost(pick(), "bench post");
+    cout << "post (incl. snapshot publish):\t\t" << nanosPerOp(start, updates) << " ns/op" << endl;
+
+    vector<Post *> liked;
+    for (int i = 0; i < 1000; i++)
+        for (Post *p : app.collectUserPosts(pick()))
+            liked.push_back(p);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < updates; i++)
+        app.likePost(liked[rng() % liked.size()]);
+    cout << "like:\t\t\t\t\t" << nanosPerOp(start, updates) << " ns/op" << endl;
+
+    Leaderboard board;
+    for (User *u : people)
+        board.set(u->getId(), u->getFollowers().size());
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < updates; i++)
+    {
+        User *u = people[i % userCount];
+        long long score = u->getFollowers().size();
+        board.set(u->getId(), score + 1);
+        board.set(u->getId(), score);
+    }
+    cout << "leaderboard update only:\t\t" << nanosPerOp(start, 2 * updates) << " ns/op" << endl;
+
+    size_t checksum = 0;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++)
+        checksum += app.topByFollowers(10).size();
+    cout << "top-10 by followers:\t\t\t" << nanosPerOp(start, queries) << " ns/op" << endl;
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++)
+        checksum += app.topByLikes(100).size();
+    cout << "top-100 by likes:\t\t\t" << nanosPerOp(start, queries) << " ns/op" << endl;
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++)
+        checksum += app.followerRank(people[rng() % userCount]);
+    cout << "rank of a user by followers:\t\t" << nanosPerOp(start, queries) << " ns/op" << endl;
+
+    const int sorts = 5;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < sorts; i++)
+    {
+        vector<User *> sorted = people;
+        sort(sorted.begin(), sorted.end(), [](User *a, User *b)
+             { return a->getFollowers().size() > b->getFollowers().size(); });
+        checksum += sorted[0]->getFollowers().size();
+    }
+    cout << "baseline full sort by followers:\t" << nanosPerOp(start, sorts) << " ns/op" << endl;
+    cout << "checksum: " << checksum << endl;
+}
+
+int main(int argc, char *argv[])
 {
+    if (argc > 1 && string(argv[1]) == "--bench-feed")
+    {
+        runFeedBenchmark();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--memstats")
+    {
+        if (argc > 2)
+            runMemoryReport(atoi(argv[2]));
+        else
+            SocialMedia().displayMemoryStats();
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "--bench-leaderboard")
+    {
+        runLeaderboardBenchmark();
+        return 0;
+    }
+
     SocialMedia app;
 
     int choice;
@@ -494,7 +1756,7 @@ int main()
         {
             cout << "\033[1;32m------ Login successful!------\033[0m" << endl
                  << endl;
-            cout << "\033[1;34mWelcome \033[0m" << "\033[1;36m" << currentUser->getUsername() << "\033[0m" << endl
+            cout << "\033[1;34mWelcome \033[0m" << "\033[1;36m" << app.getUsername(currentUser) << "\033[0m" << endl
                  << endl;
             cout << "\033[1;35mPress Enter to continue...\033[0m";
             cin.ignore();
@@ -527,7 +1789,8 @@ int main()
         cout << "\033[1;36m2. Search User\033[0m" << endl;
         cout << "\033[1;36m3. Display Profile\033[0m" << endl;
         cout << "\033[1;36m4. Create Post\033[0m" << endl;
-        cout << "\033[1;36m5. Exit\033[0m" << endl;
+        cout << "\033[1;36m5. Leaderboard\033[0m" << endl;
+        cout << "\033[1;36m6. Exit\033[0m" << endl;
         cout << "\033[1;33mEnter your choice: \033[0m";
         cin >> choice;
         if (choice == 1)
@@ -568,7 +1831,7 @@ int main()
                 while (staying)
                 {
                     system("clear");
-                    searchedUser->displayProfile();
+                    app.displayProfile(searchedUser);
                     cout << "\033[1;36m1. Follow\033[0m" << endl;
                     cout << "\033[1;36m2. See Followers List\033[0m" << endl;
                     cout << "\033[1;36m3. See Following List\033[0m" << endl;
@@ -581,27 +1844,24 @@ int main()
                     switch (userChoice)
                     {
                     case 1:
-                        if (currentUser->isFollowing(searchedUser))
+                        if (app.isFollowing(currentUser, searchedUser))
                         {
-                            cout << "\033[1;36mYou are already following : " << searchedUser->getUsername() << "\033[0m" << endl;
+                            cout << "\033[1;36mYou are already following : " << app.getUsername(searchedUser) << "\033[0m" << endl;
                             cout << "\033[1;33mEnter 1 to Unfollow or any other key to cancel: \033[0m";
                             int choice;
                             cin >> choice;
                             if (choice == 1)
                             {
-                                auto &following = const_cast<vector<User *> &>(currentUser->getFollowing());
-                                auto &followers = const_cast<vector<User *> &>(searchedUser->getFollowers());
-                                following.erase(remove(following.begin(), following.end(), searchedUser), following.end());
-                                followers.erase(remove(followers.begin(), followers.end(), currentUser), followers.end());
+                                app.unfollowUser(currentUser, searchedUser);
                                 app.saveUsersToFile();
-                                cout << "\033[1;32mYou are no longer following " << searchedUser->getUsername() << "!\033[0m" << endl;
+                                cout << "\033[1;32mYou are no longer following " << app.getUsername(searchedUser) << "!\033[0m" << endl;
                             }
                         }
                         else
                         {
-                            currentUser->follow(searchedUser);
+                            app.followUser(currentUser, searchedUser);
                             app.saveUsersToFile();
-                            cout << "\033[1;32mYou are now following " << searchedUser->getUsername() << "!\033[0m" << endl;
+                            cout << "\033[1;32mYou are now following " << app.getUsername(searchedUser) << "!\033[0m" << endl;
                         }
                         app.saveUsersToFile();
                         cout << "\033[1;35mPress Enter to continue...\033[0m";
@@ -609,19 +1869,19 @@ int main()
                         cin.get();
                         break;
                     case 2:
-                        searchedUser->displayFollowers();
+                        app.displayFollowers(searchedUser);
                         cout << "\033[1;35mPress Enter to continue...\033[0m";
                         cin.ignore();
                         cin.get();
                         break;
                     case 3:
-                        searchedUser->displayFollowing();
+                        app.displayFollowing(searchedUser);
                         cout << "\033[1;35mPress Enter to continue...\033[0m";
                         cin.ignore();
                         cin.get();
                         break;
                     case 4:
-                        searchedUser->displayContents();
+                        app.displayContents(searchedUser);
                         cout << "\033[1;35mPress Enter to continue...\033[0m";
                         cin.ignore();
                         cin.get();
@@ -653,7 +1913,7 @@ int main()
                 system("clear");
                 cout << endl
                      << "\033[1;34m--------- User Profile ----------\033[0m" << endl;
-                currentUser->displayProfile();
+                app.displayProfile(currentUser);
                 cout << "\033[1;36m1. See Followers List\033[0m" << endl;
                 cout << "\033[1;36m2. See Following List\033[0m" << endl;
                 cout << "\033[1;36m3. See All Posts\033[0m" << endl;
@@ -665,19 +1925,19 @@ int main()
                 switch (userChoice)
                 {
                 case 1:
-                    currentUser->displayFollowers();
+                    app.displayFollowers(currentUser);
                     cout << "\033[1;35mPress Enter to continue...\033[0m";
                     cin.ignore();
                     cin.get();
                     break;
                 case 2:
-                    currentUser->displayFollowing();
+                    app.displayFollowing(currentUser);
                     cout << "\033[1;35mPress Enter to continue...\033[0m";
                     cin.ignore();
                     cin.get();
                     break;
                 case 3:
-                    currentUser->displayContents();
+                    app.displayContents(currentUser);
                     cout << "\033[1;35mPress Enter to continue...\033[0m";
                     cin.ignore();
                     cin.get();
@@ -705,6 +1965,14 @@ int main()
             cin.get();
         }
         else if (choice == 5)
+        {
+            system("clear");
+            app.displayLeaderboards(10);
+            cout << "\033[1;35mPress Enter to continue...\033[0m";
+            cin.ignore();
+            cin.get();
+        }
+        else if (choice == 6)
         {
             cout << endl
                  << endl
@@ -721,4 +1989,4 @@ int main()
     }
 
     return 0;
-}
\ No newline at end of file
+}